@@ -0,0 +1,384 @@
+// checkpoint.c
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "nn.h"
+
+// File layout (native endianness):
+//   magic, version, step, n_layers, sizes[n_layers + 1], n_params,
+//   has_opt, t, data[n_params], then m[n_params] and v[n_params] if has_opt,
+//   and finally a 64-bit FNV-1a checksum of all preceding bytes
+#define CKPT_MAGIC 0x4b43474dU  // "MGCK"
+#define CKPT_VERSION 2
+#define CKPT_PREFIX "ckpt-"
+#define CKPT_SUFFIX ".bin"
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+
+static void fnv1a(uint64_t *hash, const void *ptr, size_t len) {
+    const unsigned char *bytes = (const unsigned char*)ptr;
+    for (size_t i = 0; i < len; i++) {
+        *hash = (*hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+}
+
+// fwrite/fread that also feed the bytes into the running checksum
+static int put(FILE *f, const void *ptr, size_t size, size_t count, uint64_t *hash) {
+    fnv1a(hash, ptr, size * count);
+    return fwrite(ptr, size, count, f) == count;
+}
+
+static int get(FILE *f, void *ptr, size_t size, size_t count, uint64_t *hash) {
+    if (fread(ptr, size, count, f) != count) return 0;
+    fnv1a(hash, ptr, size * count);
+    return 1;
+}
+
+static void mlp_sizes(MLP *mlp, int *sizes) {
+    sizes[0] = mlp->layers[0].neurons[0].n_inputs;
+    for (int i = 0; i < mlp->n_layers; i++) {
+        sizes[i + 1] = mlp->layers[i].n_neurons;
+    }
+}
+
+static int is_ckpt_name(const char *name) {
+    size_t len = strlen(name);
+    return strncmp(name, CKPT_PREFIX, strlen(CKPT_PREFIX)) == 0
+           && len > strlen(CKPT_SUFFIX)
+           && strcmp(name + len - strlen(CKPT_SUFFIX), CKPT_SUFFIX) == 0;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Checkpoint file names in dir, oldest first (steps are zero-padded)
+static char** list_checkpoints(const char *dir, int *count) {
+    *count = 0;
+    DIR *d = opendir(dir);
+    if (d == NULL) return NULL;
+
+    char **names = NULL;
+    int cap = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (!is_ckpt_name(entry->d_name)) continue;
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 16;
+            names = realloc(names, cap * sizeof(char*));
+        }
+        names[(*count)++] = strdup(entry->d_name);
+    }
+    closedir(d);
+
+    qsort(names, *count, sizeof(char*), compare_names);
+    return names;
+}
+
+static void free_names(char **names, int count) {
+    for (int i = 0; i < count; i++) free(names[i]);
+    free(names);
+}
+
+// Returns 0 on success, otherwise the errno of the failed call
+static int write_buffer(Checkpointer *ck, CheckpointBuffer *buf) {
+    char path[512], tmp[520];
+    snprintf(path, sizeof(path), "%s/" CKPT_PREFIX "%012ld" CKPT_SUFFIX, ck->dir, buf->step);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    errno = 0;
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        int err = errno;
+        perror("fopen");
+        return err;
+    }
+
+    unsigned int magic = CKPT_MAGIC;
+    int version = CKPT_VERSION;
+    size_t n = ck->n_params;
+    uint64_t hash = FNV_OFFSET;
+    int ok = put(f, &magic, sizeof(magic), 1, &hash)
+             && put(f, &version, sizeof(version), 1, &hash)
+             && put(f, &buf->step, sizeof(buf->step), 1, &hash)
+             && put(f, &ck->n_layers, sizeof(int), 1, &hash)
+             && put(f, ck->sizes, sizeof(int), ck->n_layers + 1, &hash)
+             && put(f, &ck->n_params, sizeof(int), 1, &hash)
+             && put(f, &buf->has_opt, sizeof(int), 1, &hash)
+             && put(f, &buf->t, sizeof(int), 1, &hash)
+             && put(f, buf->data, sizeof(double), n, &hash)
+             && (!buf->has_opt || (put(f, buf->m, sizeof(double), n, &hash)
+                                   && put(f, buf->v, sizeof(double), n, &hash)));
+    ok = ok && fwrite(&hash, sizeof(hash), 1, f) == 1;
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+
+    // Rename last, so a crash mid-write never leaves a truncated checkpoint
+    if (!ok || rename(tmp, path) != 0) {
+        int err = errno ? errno : EIO;
+        perror("Failed to write checkpoint");
+        unlink(tmp);
+        return err;
+    }
+
+    // The rename itself is only durable once the directory is synced
+    int dir_fd = open(ck->dir, O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0 || fsync(dir_fd) != 0) {
+        int err = errno;
+        perror("Failed to sync checkpoint directory");
+        if (dir_fd >= 0) close(dir_fd);
+        return err;
+    }
+    close(dir_fd);
+    return 0;
+}
+
+// Delete all but the ck->keep most recent checkpoints
+static void rotate(Checkpointer *ck) {
+    int count;
+    char **names = list_checkpoints(ck->dir, &count);
+    for (int i = 0; i < count - ck->keep; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", ck->dir, names[i]);
+        unlink(path);
+    }
+    free_names(names, count);
+}
+
+static void* ckpt_writer(void *arg) {
+    Checkpointer *ck = (Checkpointer*)arg;
+
+    pthread_mutex_lock(&ck->lock);
+    for (;;) {
+        CheckpointBuffer *buf = NULL;
+        for (int i = 0; i < 2; i++) {
+            if (ck->buffers[i].state == CKPT_PENDING) buf = &ck->buffers[i];
+        }
+        if (buf == NULL) {
+            if (ck->closing) break;
+            pthread_cond_wait(&ck->cond, &ck->lock);
+            continue;
+        }
+
+        buf->state = CKPT_WRITING;
+        pthread_mutex_unlock(&ck->lock);
+
+        int err = write_buffer(ck, buf);
+        if (err == 0) rotate(ck);
+
+        pthread_mutex_lock(&ck->lock);
+        if (err != 0) ck->error = err;
+        buf->state = CKPT_FREE;
+        pthread_cond_broadcast(&ck->cond);
+    }
+    pthread_mutex_unlock(&ck->lock);
+    return NULL;
+}
+
+static void free_checkpointer(Checkpointer *ck) {
+    for (int i = 0; i < 2; i++) {
+        free(ck->buffers[i].data);
+        free(ck->buffers[i].m);
+        free(ck->buffers[i].v);
+    }
+    free(ck->sizes);
+    free(ck->params);
+    pthread_mutex_destroy(&ck->lock);
+    pthread_cond_destroy(&ck->cond);
+}
+
+// Start a background writer for mlp's checkpoints in dir, keeping the
+// last `keep` files. dir must be an existing, writable directory.
+// Returns 0 on success, -1 on failure.
+int ckpt_init(Checkpointer *ck, const char *dir, int keep, MLP *mlp) {
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || access(dir, W_OK | X_OK) != 0) {
+        fprintf(stderr, "Error: checkpoint directory %s is not a writable directory\n", dir);
+        return -1;
+    }
+
+    snprintf(ck->dir, sizeof(ck->dir), "%s", dir);
+    ck->keep = keep > 0 ? keep : 1;
+    ck->n_layers = mlp->n_layers;
+    ck->sizes = malloc((mlp->n_layers + 1) * sizeof(int));
+    mlp_sizes(mlp, ck->sizes);
+    ck->n_params = mlp_n_params(mlp);
+    ck->params = mlp_parameters(mlp);
+    ck->closing = 0;
+    ck->error = 0;
+
+    for (int i = 0; i < 2; i++) {
+        CheckpointBuffer *buf = &ck->buffers[i];
+        buf->state = CKPT_FREE;
+        buf->data = malloc(ck->n_params * sizeof(double));
+        buf->m = malloc(ck->n_params * sizeof(double));
+        buf->v = malloc(ck->n_params * sizeof(double));
+        if (!buf->data || !buf->m || !buf->v) {
+            fprintf(stderr, "Failed to allocate checkpoint buffers\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_mutex_init(&ck->lock, NULL);
+    pthread_cond_init(&ck->cond, NULL);
+    int err = pthread_create(&ck->thread, NULL, ckpt_writer, ck);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(err));
+        free_checkpointer(ck);
+        return -1;
+    }
+    return 0;
+}
+
+// Snapshot parameters (and opt's state, if not NULL) at a step boundary
+// and hand them to the writer thread. The caller only pays for the copy.
+// If the previous snapshot hasn't started writing yet it is replaced, so
+// a slow disk drops intermediate checkpoints instead of stalling training.
+void ckpt_save_async(Checkpointer *ck, Adam *opt, long step) {
+    pthread_mutex_lock(&ck->lock);
+    CheckpointBuffer *buf = NULL;
+    while (buf == NULL) {
+        for (int i = 0; i < 2 && buf == NULL; i++) {
+            if (ck->buffers[i].state == CKPT_PENDING) buf = &ck->buffers[i];
+        }
+        for (int i = 0; i < 2 && buf == NULL; i++) {
+            if (ck->buffers[i].state == CKPT_FREE) buf = &ck->buffers[i];
+        }
+        if (buf == NULL) pthread_cond_wait(&ck->cond, &ck->lock);  // not reached with one writer
+    }
+    buf->state = CKPT_FILLING;
+    pthread_mutex_unlock(&ck->lock);
+
+    buf->step = step;
+    buf->has_opt = (opt != NULL);
+    for (int i = 0; i < ck->n_params; i++) {
+        buf->data[i] = ck->params[i]->data;
+    }
+    if (opt != NULL) {
+        buf->t = opt->t;
+        memcpy(buf->m, opt->m, ck->n_params * sizeof(double));
+        memcpy(buf->v, opt->v, ck->n_params * sizeof(double));
+    } else {
+        buf->t = 0;
+    }
+
+    pthread_mutex_lock(&ck->lock);
+    buf->state = CKPT_PENDING;
+    pthread_cond_broadcast(&ck->cond);
+    pthread_mutex_unlock(&ck->lock);
+}
+
+// Block until every snapshot taken so far is on disk. Returns 0 if every
+// write since the last ckpt_wait succeeded, otherwise -1 with errno set.
+int ckpt_wait(Checkpointer *ck) {
+    pthread_mutex_lock(&ck->lock);
+    while (ck->buffers[0].state != CKPT_FREE || ck->buffers[1].state != CKPT_FREE) {
+        pthread_cond_wait(&ck->cond, &ck->lock);
+    }
+    int err = ck->error;
+    ck->error = 0;
+    pthread_mutex_unlock(&ck->lock);
+
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+// Flush pending snapshots and stop the writer thread. Returns 0 if every
+// write since the last ckpt_wait succeeded, otherwise -1 with errno set.
+int ckpt_close(Checkpointer *ck) {
+    pthread_mutex_lock(&ck->lock);
+    ck->closing = 1;
+    pthread_cond_broadcast(&ck->cond);
+    pthread_mutex_unlock(&ck->lock);
+    pthread_join(ck->thread, NULL);
+
+    int err = ck->error;
+    free_checkpointer(ck);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+static int read_checkpoint(const char *path, MLP *mlp, Adam *opt, long *step) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return -1;
+
+    int n_layers = mlp->n_layers;
+    int *expected = malloc((n_layers + 1) * sizeof(int));
+    int *sizes = malloc((n_layers + 1) * sizeof(int));
+    mlp_sizes(mlp, expected);
+    int n_params = mlp_n_params(mlp);
+    double *data = malloc(n_params * sizeof(double));
+    double *m = malloc(n_params * sizeof(double));
+    double *v = malloc(n_params * sizeof(double));
+
+    unsigned int magic;
+    int version, file_layers, file_params, has_opt, t;
+    long file_step;
+    uint64_t stored_hash;
+    size_t n = n_params;
+    uint64_t hash = FNV_OFFSET;
+    int ok = get(f, &magic, sizeof(magic), 1, &hash) && magic == CKPT_MAGIC
+             && get(f, &version, sizeof(version), 1, &hash) && version == CKPT_VERSION
+             && get(f, &file_step, sizeof(file_step), 1, &hash)
+             && get(f, &file_layers, sizeof(int), 1, &hash) && file_layers == n_layers
+             && get(f, sizes, sizeof(int), n_layers + 1, &hash)
+             && memcmp(sizes, expected, (n_layers + 1) * sizeof(int)) == 0
+             && get(f, &file_params, sizeof(int), 1, &hash) && file_params == n_params
+             && get(f, &has_opt, sizeof(int), 1, &hash)
+             && get(f, &t, sizeof(int), 1, &hash)
+             && get(f, data, sizeof(double), n, &hash)
+             && (!has_opt || (get(f, m, sizeof(double), n, &hash)
+                              && get(f, v, sizeof(double), n, &hash)))
+             && fread(&stored_hash, sizeof(stored_hash), 1, f) == 1
+             && stored_hash == hash
+             && fgetc(f) == EOF;
+    fclose(f);
+
+    if (ok) {
+        Value **params = mlp_parameters(mlp);
+        for (int i = 0; i < n_params; i++) {
+            params[i]->data = data[i];
+        }
+        free(params);
+        if (opt != NULL && has_opt) {
+            opt->t = t;
+            memcpy(opt->m, m, n * sizeof(double));
+            memcpy(opt->v, v, n * sizeof(double));
+        }
+        if (step != NULL) *step = file_step;
+    }
+
+    free(expected);
+    free(sizes);
+    free(data);
+    free(m);
+    free(v);
+    return ok ? 0 : -1;
+}
+
+// Restore mlp (and opt, if not NULL) from the newest checkpoint in dir that
+// matches mlp's shape and passes its checksum, skipping corrupt files. Returns 0 on success, -1 if none.
+int ckpt_load_latest(const char *dir, MLP *mlp, Adam *opt, long *step) {
+    int count;
+    char **names = list_checkpoints(dir, &count);
+    int rc = -1;
+    for (int i = count - 1; i >= 0 && rc != 0; i--) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        rc = read_checkpoint(path, mlp, opt, step);
+    }
+    free_names(names, count);
+    return rc;
+}
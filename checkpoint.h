@@ -0,0 +1,46 @@
+// checkpoint.h
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <pthread.h>
+#include "nn.h"
+
+typedef enum {
+    CKPT_FREE,              // Unused
+    CKPT_FILLING,           // Being copied from the live model
+    CKPT_PENDING,           // Waiting for the writer thread
+    CKPT_WRITING            // Being written to disk
+} CheckpointState;
+
+typedef struct {
+    CheckpointState state;
+    long step;
+    int t;                  // Adam step counter
+    int has_opt;            // m and v are valid
+    double *data;           // Parameter values
+    double *m;              // Adam 1st moment
+    double *v;              // Adam 2nd moment
+} CheckpointBuffer;
+
+typedef struct {
+    char dir[256];          // Directory holding the checkpoint files
+    int keep;               // Number of most recent checkpoints kept on disk
+    int n_layers;
+    int *sizes;             // nin followed by the size of every layer
+    int n_params;
+    Value **params;         // Live parameters, in mlp_parameters() order
+    CheckpointBuffer buffers[2];
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int closing;
+    int error;              // errno of the last failed write not yet reported, 0 if none
+} Checkpointer;
+
+int ckpt_init(Checkpointer *ck, const char *dir, int keep, MLP *mlp);
+void ckpt_save_async(Checkpointer *ck, Adam *opt, long step);
+int ckpt_wait(Checkpointer *ck);
+int ckpt_close(Checkpointer *ck);
+int ckpt_load_latest(const char *dir, MLP *mlp, Adam *opt, long *step);
+
+#endif
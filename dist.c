@@ -0,0 +1,281 @@
+// dist.c
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "dist.h"
+#include "nn.h"
+
+// Everything the workers exchange lives in one POSIX shm segment, mapped
+// before fork so every worker sees it at the same address.
+typedef struct {
+    pthread_barrier_t barrier;
+    int n_workers;
+    int n_params;
+} DistHeader;
+
+typedef struct {
+    DistHeader *header;
+    double *loss;           // Local loss of each worker, current step
+    double *history;        // Mean loss per step (written by rank 0)
+    double *grads;          // One gradient buffer per worker
+    double *result;         // Final parameters (written by rank 0)
+    size_t size;
+} DistShared;
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+static int shared_open(DistShared *sh, int n_workers, int n_params, int n_steps) {
+    size_t header = align8(sizeof(DistHeader));
+    size_t n_doubles = n_workers + n_steps + (size_t)n_workers * n_params + n_params;
+    sh->size = header + n_doubles * sizeof(double);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/micrograd-dist-%d", (int)getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        return -1;
+    }
+    shm_unlink(name);  // The mapping outlives the name; nothing to clean up later
+
+    if (ftruncate(fd, sh->size) != 0) {
+        perror("ftruncate");
+        close(fd);
+        return -1;
+    }
+    void *base = mmap(NULL, sh->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    sh->header = (DistHeader*)base;
+    sh->loss = (double*)((char*)base + header);
+    sh->history = sh->loss + n_workers;
+    sh->grads = sh->history + n_steps;
+    sh->result = sh->grads + (size_t)n_workers * n_params;
+
+    sh->header->n_workers = n_workers;
+    sh->header->n_params = n_params;
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&sh->header->barrier, &attr, n_workers);
+    pthread_barrierattr_destroy(&attr);
+    return 0;
+}
+
+static void shared_close(DistShared *sh, int failed) {
+    // A killed worker can die inside the barrier, and glibc's destroy then
+    // waits forever for it to leave. Every worker is reaped by now, so the
+    // barrier is simply dropped with the mapping in that case.
+    if (!failed) pthread_barrier_destroy(&sh->header->barrier);
+    munmap(sh->header, sh->size);
+}
+
+static void chunk_range(int c, int n_workers, int n_params, int *lo, int *hi) {
+    *lo = (int)((long)c * n_params / n_workers);
+    *hi = (int)((long)(c + 1) * n_params / n_workers);
+}
+
+// Sum the gradient buffers of all workers and write the mean into out.
+// Ring mode: N-1 reduce-scatter steps, each worker adding one chunk from its
+// left neighbour, so every step moves 1/N of the gradient per worker.
+// Deterministic mode: the owner of each chunk sums all buffers in rank
+// order, matching a serial sum over shards independently of N's chunking.
+static void allreduce(DistShared *sh, int rank, int deterministic, double *out) {
+    int n_workers = sh->header->n_workers;
+    int n_params = sh->header->n_params;
+    double *mine = sh->grads + (size_t)rank * n_params;
+    int lo, hi;
+
+    pthread_barrier_wait(&sh->header->barrier);  // all local grads written
+
+    if (deterministic) {
+        chunk_range(rank, n_workers, n_params, &lo, &hi);
+        for (int i = lo; i < hi; i++) {
+            double acc = 0.0;
+            for (int w = 0; w < n_workers; w++) {
+                acc += sh->grads[(size_t)w * n_params + i];
+            }
+            mine[i] = acc;
+        }
+        pthread_barrier_wait(&sh->header->barrier);
+    } else {
+        double *left = sh->grads + (size_t)((rank - 1 + n_workers) % n_workers) * n_params;
+        for (int s = 0; s < n_workers - 1; s++) {
+            int c = ((rank - s - 1) % n_workers + n_workers) % n_workers;
+            chunk_range(c, n_workers, n_params, &lo, &hi);
+            for (int i = lo; i < hi; i++) {
+                mine[i] += left[i];
+            }
+            pthread_barrier_wait(&sh->header->barrier);
+        }
+    }
+
+    // Allgather: read every fully reduced chunk straight from its owner
+    for (int c = 0; c < n_workers; c++) {
+        int owner = deterministic ? c : (c - 1 + n_workers) % n_workers;
+        double *src = sh->grads + (size_t)owner * n_params;
+        chunk_range(c, n_workers, n_params, &lo, &hi);
+        for (int i = lo; i < hi; i++) {
+            out[i] = src[i] / n_workers;
+        }
+    }
+
+    pthread_barrier_wait(&sh->header->barrier);  // buffers free for next step
+}
+
+static void worker_run(DistShared *sh, MLP *mlp, int rank, DistConfig *config,
+                       DistStepFn step_fn, void *ctx) {
+    // The replica is the parent's MLP inherited through fork; its pages are
+    // copied on first write, so each worker's parameters end up local to it.
+    Adam opt;
+    adam_init(&opt, mlp, config->lr, config->beta1, config->beta2, config->eps);
+    double *mine = sh->grads + (size_t)rank * opt.n_params;
+    double *reduced = malloc(opt.n_params * sizeof(double));
+
+    for (int step = 0; step < config->n_steps; step++) {
+        mlp_zero_grad(mlp);
+        sh->loss[rank] = step_fn(mlp, rank, config->n_workers, step, ctx);
+        for (int i = 0; i < opt.n_params; i++) {
+            mine[i] = opt.params[i]->grad;
+        }
+
+        allreduce(sh, rank, config->deterministic, reduced);
+
+        if (rank == 0) {
+            double loss = 0.0;
+            for (int w = 0; w < config->n_workers; w++) loss += sh->loss[w];
+            sh->history[step] = loss / config->n_workers;
+        }
+        // Every worker applies the same update to the same reduced gradient
+        for (int i = 0; i < opt.n_params; i++) {
+            opt.params[i]->grad = reduced[i];
+        }
+        adam_step(&opt);
+
+        // Don't let a fast worker overwrite its loss slot before rank 0 reads it
+        pthread_barrier_wait(&sh->header->barrier);
+    }
+
+    if (rank == 0) {
+        for (int i = 0; i < opt.n_params; i++) {
+            sh->result[i] = opt.params[i]->data;
+        }
+    }
+
+    free(reduced);
+    adam_free(&opt);
+}
+
+static void kill_workers(pid_t *pids, int *alive, int n) {
+    for (int i = 0; i < n; i++) {
+        if (alive[i]) kill(pids[i], SIGKILL);
+    }
+}
+
+// Wait for exactly the given workers (never other children of the caller).
+// Workers block on the barrier until all of them exist, so a missing or
+// crashed worker would hang the rest: the workers are polled rather than
+// waited on in order, and all of them are killed on the first failure.
+// Returns 0 only if every worker exited with EXIT_SUCCESS.
+static int reap_workers(pid_t *pids, int n, int failed) {
+    int *alive = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) alive[i] = 1;
+    if (failed) kill_workers(pids, alive, n);
+
+    int remaining = n;
+    while (remaining > 0) {
+        int progressed = 0;
+        for (int i = 0; i < n; i++) {
+            if (!alive[i]) continue;
+
+            int status;
+            pid_t pid = waitpid(pids[i], &status, failed ? 0 : WNOHANG);
+            if (pid == 0) continue;
+            if (pid < 0 && errno == EINTR) continue;
+
+            alive[i] = 0;
+            remaining--;
+            progressed = 1;
+            int ok = pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+            if (!ok && !failed) {
+                if (pid < 0) perror("waitpid");
+                else fprintf(stderr, "Worker %d failed\n", (int)pids[i]);
+                failed = 1;
+                kill_workers(pids, alive, n);
+            }
+        }
+        if (!progressed && !failed) {
+            struct timespec delay = {0, 1000000};  // 1 ms
+            nanosleep(&delay, NULL);
+        }
+    }
+
+    free(alive);
+    return failed ? -1 : 0;
+}
+
+// Train mlp with config.n_workers forked replicas. On success the trained
+// parameters are copied back into mlp, losses (if not NULL) receives the
+// mean loss of each step, and 0 is returned. Returns -1 on failure.
+int dist_train(MLP *mlp, DistConfig config, DistStepFn step_fn, void *ctx, double *losses) {
+    if (config.n_workers <= 0) {
+        fprintf(stderr, "Error: n_workers must be > 0\n");
+        return -1;
+    }
+
+    DistShared sh;
+    int n_params = mlp_n_params(mlp);
+    if (shared_open(&sh, config.n_workers, n_params, config.n_steps) != 0) return -1;
+
+    pid_t *pids = malloc(config.n_workers * sizeof(pid_t));
+    int failed = 0;
+    int spawned = 0;
+
+    fflush(NULL);  // Don't duplicate buffered output into the children
+    for (; spawned < config.n_workers; spawned++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            failed = 1;
+            break;
+        }
+        if (pid == 0) {
+            worker_run(&sh, mlp, spawned, &config, step_fn, ctx);
+            fflush(NULL);
+            _exit(EXIT_SUCCESS);
+        }
+        pids[spawned] = pid;
+    }
+
+    if (reap_workers(pids, spawned, failed) != 0) failed = 1;
+
+    if (!failed) {
+        Value **params = mlp_parameters(mlp);
+        for (int i = 0; i < n_params; i++) {
+            params[i]->data = sh.result[i];
+        }
+        free(params);
+        if (losses != NULL) {
+            memcpy(losses, sh.history, config.n_steps * sizeof(double));
+        }
+    }
+
+    free(pids);
+    shared_close(&sh, failed);
+    return failed ? -1 : 0;
+}
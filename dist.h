@@ -0,0 +1,21 @@
+// dist.h
+#ifndef DIST_H
+#define DIST_H
+
+#include "nn.h"
+
+// Computes the local loss and leaves the local gradient in mlp's params.
+// Grads are zeroed before each call; the gradient should be the mean over
+// this worker's shard, since dist_train averages it across workers.
+typedef double (*DistStepFn)(MLP *mlp, int rank, int n_workers, int step, void *ctx);
+
+typedef struct {
+    int n_workers;          // Number of worker processes
+    int n_steps;            // Number of optimizer steps
+    int deterministic;      // Reduce in rank order instead of ring order
+    double lr, beta1, beta2, eps;
+} DistConfig;
+
+int dist_train(MLP *mlp, DistConfig config, DistStepFn step_fn, void *ctx, double *losses);
+
+#endif
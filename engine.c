@@ -1,5 +1,6 @@
 // engine.c
 #include <math.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -41,8 +42,11 @@ Value* create_value(double data) {
     v->grad = 0.0;
     v->prev[0] = NULL;
     v->prev[1] = NULL;
+    v->children = NULL;
+    v->n_children = 0;
     v->op[0] = '\0';
     v->backward = NULL;
+    v->visit = 0;
 
     return v;
 }
@@ -124,60 +128,121 @@ Value* truediv(Value* a, Value* b) {
 }
 
 // Backward function
-void build_topo(Value* v, Value** topo, int* topo_size, Value** visited, int* visited_size) {
-    Value** stack = malloc(10000 * sizeof(Value*));
-    int stack_size = 0;
-    stack[stack_size++] = v;
-
-    while (stack_size > 0) {
-        Value* node = stack[--stack_size];
-        
-        // Skip if already visited
-        int is_visited = 0;
-        for (int i = 0; i < *visited_size; i++) {
-            if (visited[i] == node) {
-                is_visited = 1;
-                break;
+
+// Every traversal gets a fresh stamp, so marking a node visited is O(1)
+// and nothing needs to be cleared afterwards. The counter is 64-bit so it
+// never wraps back to 0, the stamp create_value gives new nodes.
+static atomic_ullong topo_epoch = 0;
+
+typedef struct {
+    Value* node;
+    int expanded;    // children already pushed
+} TopoFrame;
+
+static void* grow(void* buf, int* cap, size_t elem_size) {
+    *cap = (*cap == 0) ? 1024 : *cap * 2;
+    buf = realloc(buf, *cap * elem_size);
+    if (buf == NULL) {
+        fprintf(stderr, "Failed to grow topo buffer\n");
+        exit(EXIT_FAILURE);
+    }
+    return buf;
+}
+
+static void push_frame(TopoFrame** stack, int* size, int* cap, Value* v) {
+    if (*size == *cap) *stack = grow(*stack, cap, sizeof(TopoFrame));
+    (*stack)[*size].node = v;
+    (*stack)[*size].expanded = 0;
+    (*size)++;
+}
+
+// Post-order DFS from all roots at once: each node appears in topo after
+// every node it depends on, and shared subgraphs are walked only once.
+Value** build_topo(Value** roots, int n_roots, int* topo_size) {
+    unsigned long long epoch = atomic_fetch_add(&topo_epoch, 1) + 1;
+
+    Value** topo = NULL;
+    int topo_cap = 0;
+    *topo_size = 0;
+
+    TopoFrame* stack = NULL;
+    int stack_size = 0, stack_cap = 0;
+
+    for (int r = 0; r < n_roots; r++) {
+        push_frame(&stack, &stack_size, &stack_cap, roots[r]);
+
+        while (stack_size > 0) {
+            TopoFrame* top = &stack[stack_size - 1];
+            Value* node = top->node;
+
+            if (top->expanded) {
+                stack_size--;
+                if (*topo_size == topo_cap) topo = grow(topo, &topo_cap, sizeof(Value*));
+                topo[(*topo_size)++] = node;
+                continue;
             }
-        }
-        if (is_visited) continue;
-        
-        // Mark as visited
-        visited[(*visited_size)++] = node;
-        
-        // Push children onto the stack (right first, then left)
-        for (int i = 1; i >= 0; i--) {
-            if (node->prev[i] != NULL) {
-                stack[stack_size++] = node->prev[i];
+            if (node->visit == epoch) {
+                stack_size--;
+                continue;
+            }
+
+            node->visit = epoch;
+            top->expanded = 1;
+            for (int i = node->n_children - 1; i >= 0; i--) {
+                if (node->children[i]->visit != epoch) {
+                    push_frame(&stack, &stack_size, &stack_cap, node->children[i]);
+                }
+            }
+            for (int i = 1; i >= 0; i--) {
+                if (node->prev[i] != NULL && node->prev[i]->visit != epoch) {
+                    push_frame(&stack, &stack_size, &stack_cap, node->prev[i]);
+                }
             }
         }
     }
-    
-    // Reverse visited to get topological order
-    for (int i = *visited_size - 1; i >= 0; i--) {
-        topo[(*topo_size)++] = visited[i];
-    }
-    
+
     free(stack);
+    return topo;
 }
 
-void backward(Value* v) {
-    const int max_nodes = 1000000; // Increased buffer size
-    Value** topo = malloc(max_nodes * sizeof(Value*));
-    Value** visited = malloc(max_nodes * sizeof(Value*));
+// One traversal and one reverse sweep for all roots. Each root's grad is
+// increased by its seed (1.0 when seeds is NULL) before the sweep.
+void backward_many(Value** roots, int n, double* seeds) {
     int topo_size = 0;
-    int visited_size = 0;
-
-    build_topo(v, topo, &topo_size, visited, &visited_size);
+    Value** topo = build_topo(roots, n, &topo_size);
 
-    v->grad = 1.0;
+    for (int i = 0; i < n; i++) {
+        roots[i]->grad += (seeds != NULL) ? seeds[i] : 1.0;
+    }
     for (int i = topo_size - 1; i >= 0; i--) {
-    if (topo[i]->backward != NULL) {
-        topo[i]->backward(topo[i]);
+        if (topo[i]->backward != NULL) {
+            topo[i]->backward(topo[i]);
+        }
     }
-}
 
     free(topo);
-    free(visited);
 }
 
+void backward(Value* v) {
+    v->grad = 0.0;
+    backward_many(&v, 1, NULL);
+}
+
+// Free every node reachable from root except the ones in keep (typically the
+// model parameters), so a training step can release its graph.
+void free_graph(Value* root, Value** keep, int n_keep) {
+    int topo_size = 0;
+    Value** topo = build_topo(&root, 1, &topo_size);
+
+    unsigned long long epoch = atomic_fetch_add(&topo_epoch, 1) + 1;
+    for (int i = 0; i < n_keep; i++) {
+        keep[i]->visit = epoch;
+    }
+    for (int i = 0; i < topo_size; i++) {
+        if (topo[i]->visit != epoch) {
+            free(topo[i]);
+        }
+    }
+
+    free(topo);
+}
@@ -8,8 +8,11 @@ typedef struct Value {
     double data;                        // scalar value
     double grad;                        // gradient of the value
     struct Value* prev[2];              // pointers to previous values (binary operations only)
+    struct Value** children;            // Extra inputs of fused n-ary operations
+    int n_children;                     // Number of entries in children
     char op[10];                        // operation that produced this value
     void (*backward)(struct Value*);    // Function pointer for backpropagation
+    unsigned long long visit;           // Traversal stamp used by build_topo
 } Value;
 
 Value* create_value(double data);
@@ -21,6 +24,8 @@ Value* neg(Value* a);
 Value* sub(Value* a, Value* b);
 Value* truediv(Value* a, Value* b);
 void backward(Value* v);
+void backward_many(Value** roots, int n, double* seeds);
+void free_graph(Value* root, Value** keep, int n_keep);
 char* repr(Value* v);
 
 #endif
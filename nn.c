@@ -1,7 +1,12 @@
 // nn.c
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "nn.h"
 #include "engine.h"
 
@@ -13,7 +18,8 @@ void neuron_zero_grad(Neuron *neuron) {
     neuron->b->grad = 0;
 }
 
-void neuron_init(Neuron *neuron, int n_inputs, NeuronConfig config) {
+// Allocate a neuron with all-zero weights and bias (no rand() draws)
+static void neuron_alloc(Neuron *neuron, int n_inputs, NeuronConfig config) {
     // Guard against invalid input size
     if (n_inputs <= 0) {
         fprintf(stderr, "Error: n_inputs must be > 0\n");
@@ -29,9 +35,8 @@ void neuron_init(Neuron *neuron, int n_inputs, NeuronConfig config) {
     neuron->n_inputs = n_inputs;
     neuron->config = config;
 
-    // He initialization with validation
     for (int i = 0; i < n_inputs; i++) {
-        neuron->w[i] = create_value(((double)rand() / RAND_MAX) * 2 - 1);
+        neuron->w[i] = create_value(0.0);
         if (!neuron->w[i]) {
             fprintf(stderr, "Failed to create weight Value\n");
             exit(EXIT_FAILURE);
@@ -46,6 +51,15 @@ void neuron_init(Neuron *neuron, int n_inputs, NeuronConfig config) {
     }
 }
 
+void neuron_init(Neuron *neuron, int n_inputs, NeuronConfig config) {
+    neuron_alloc(neuron, n_inputs, config);
+
+    // He initialization
+    for (int i = 0; i < n_inputs; i++) {
+        neuron->w[i]->data = ((double)rand() / RAND_MAX) * 2 - 1;
+    }
+}
+
 Value* neuron_call(Neuron *neuron, Value **x) {
     Value *act = NULL;
     
@@ -73,6 +87,29 @@ Value* neuron_call(Neuron *neuron, Value **x) {
     return act;
 }
 
+// Only the non-zero columns get a mul/add node, so backward never reaches
+// the weights of zero inputs and their grads stay untouched.
+Value* neuron_call_sparse(Neuron *neuron, SparseInput *x) {
+    Value *act = NULL;
+
+    for (int i = 0; i < x->nnz; i++) {
+        Value *product = mul(neuron->w[x->idx[i]], x->val[i]);
+        act = (act == NULL) ? product : add(act, product);
+    }
+
+    // All-zero input: output is the bias alone
+    if (act == NULL) {
+        act = create_value(0.0);
+    }
+    act = add(act, neuron->b);
+
+    if (neuron->config.nonlin == 1) {
+        act = relu(act);
+    }
+
+    return act;
+}
+
 Value** neuron_parameters(Neuron *neuron) {
     int n_params = neuron->n_inputs + 1;
     Value **params = (Value **)malloc(n_params * sizeof(Value*));
@@ -95,6 +132,266 @@ void neuron_free(Neuron *neuron) {
     free(neuron->b);  // Free the bias Value
 }
 
+// Persistent thread pool for intra-layer (neuron-parallel) evaluation
+typedef void (*PoolFn)(void *ctx, int i);
+
+static struct {
+    pthread_mutex_t lock;       // Guards the job fields and the condvars
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    pthread_mutex_t dispatch;   // One parallel region at a time
+    pthread_t *threads;
+    int n_threads;              // Workers plus the calling thread
+    pid_t pid;                  // Process that owns the workers
+    int shutdown;
+    unsigned long generation;   // Bumped for every new job
+    PoolFn fn;
+    void *ctx;
+    int n_items;
+    atomic_int next;            // Next item to claim
+    int active;                 // Workers still inside the current job
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_cv = PTHREAD_COND_INITIALIZER,
+    .done_cv = PTHREAD_COND_INITIALIZER,
+    .dispatch = PTHREAD_MUTEX_INITIALIZER,
+    .n_threads = 1,
+};
+
+// Layers with fewer weights than this are evaluated serially
+static int parallel_threshold = 4096;
+
+static void pool_drain(PoolFn fn, void *ctx, int n_items) {
+    int i;
+    while ((i = atomic_fetch_add(&pool.next, 1)) < n_items) {
+        fn(ctx, i);
+    }
+}
+
+static void* pool_worker(void *arg) {
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (!pool.shutdown && pool.generation == seen) {
+            pthread_cond_wait(&pool.work_cv, &pool.lock);
+        }
+        if (pool.shutdown) break;
+        seen = pool.generation;
+        PoolFn fn = pool.fn;
+        void *ctx = pool.ctx;
+        int n_items = pool.n_items;
+        pthread_mutex_unlock(&pool.lock);
+
+        pool_drain(fn, ctx, n_items);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0) pthread_cond_signal(&pool.done_cv);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// Run fn(ctx, i) for i in [0, n_items), spread over the pool. Falls back to
+// a serial loop when the pool is off, already busy with another caller, or
+// was inherited through fork (the workers only exist in the parent).
+static void pool_run(PoolFn fn, void *ctx, int n_items) {
+    if (pool.n_threads <= 1 || pool.pid != getpid()
+        || pthread_mutex_trylock(&pool.dispatch) != 0) {
+        for (int i = 0; i < n_items; i++) fn(ctx, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.n_items = n_items;
+    atomic_store(&pool.next, 0);
+    pool.active = pool.n_threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_cv);
+    pthread_mutex_unlock(&pool.lock);
+
+    pool_drain(fn, ctx, n_items);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.active > 0) {
+        pthread_cond_wait(&pool.done_cv, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.dispatch);
+}
+
+static void pool_stop(void) {
+    if (pool.n_threads <= 1 || pool.pid != getpid()) return;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.work_cv);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.n_threads - 1; i++) {
+        pthread_join(pool.threads[i], NULL);
+    }
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.shutdown = 0;
+}
+
+// Use n_threads threads (the caller included) for layer evaluation; 1
+// turns the pool off. Must not be called while a layer is being evaluated.
+void nn_set_num_threads(int n_threads) {
+    pool_stop();
+    pool.n_threads = 1;
+    if (n_threads <= 1) return;
+
+    pool.threads = (pthread_t*)malloc((n_threads - 1) * sizeof(pthread_t));
+    if (pool.threads == NULL) {
+        fprintf(stderr, "Failed to allocate thread pool\n");
+        exit(EXIT_FAILURE);
+    }
+    pool.pid = getpid();
+    pool.generation = 0;  // Workers start out having seen no job
+    for (int i = 0; i < n_threads - 1; i++) {
+        if (pthread_create(&pool.threads[i], NULL, pool_worker, NULL) != 0) {
+            fprintf(stderr, "Failed to start thread pool\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    pool.n_threads = n_threads;
+}
+
+void nn_set_parallel_threshold(int min_weights) {
+    parallel_threshold = min_weights;
+}
+
+static int layer_is_parallel(Layer *layer, int n_inputs) {
+    return pool.n_threads > 1 && layer->n_neurons > 1
+           && (long)layer->n_neurons * n_inputs >= parallel_threshold;
+}
+
+// Fused layer node: in parallel mode a whole layer evaluation is one graph
+// node whose children are the layer inputs. Each neuron output is a node
+// consuming it, so the reverse sweep reaches the layer node only after every
+// output grad is final, and its backward can then spread the work over the
+// pool. Neuron j only writes the grads of its own w and b; the shared x
+// grads are summed per input column in a second pass and added serially,
+// since the same Value may appear at several input positions.
+typedef struct {
+    Value node;             // Must be first: the engine only sees this Value
+    Layer *layer;
+    int n_x;                // Number of inputs (nnz for sparse input)
+    int *idx;               // Weight column of each input (NULL: column k is x[k])
+    Value **out;            // Neuron outputs
+    double *grad;           // Pre-activation grad of each neuron
+    double *x_grad;         // Grad contribution to each input
+    // Trailing storage: grad[n_neurons], x_grad[n_x], out[n_neurons], children[n_x], idx[n_x]
+} LayerNode;
+
+static double layer_node_pre(LayerNode *ln, int j) {
+    Neuron *neuron = &ln->layer->neurons[j];
+    double act = neuron->b->data;
+    for (int k = 0; k < ln->n_x; k++) {
+        int col = ln->idx ? ln->idx[k] : k;
+        act += neuron->w[col]->data * ln->node.children[k]->data;
+    }
+    return act;
+}
+
+static void layer_node_forward_item(void *ctx, int j) {
+    LayerNode *ln = (LayerNode*)ctx;
+    double act = layer_node_pre(ln, j);
+    int nonlin = ln->layer->neurons[j].config.nonlin == 1;
+
+    Value *out = create_value(nonlin && act < 0 ? 0.01 * act : act);  // Same leak as relu()
+    if (out == NULL) {
+        fprintf(stderr, "Failed to create neuron output Value\n");
+        exit(EXIT_FAILURE);
+    }
+    out->prev[0] = &ln->node;
+    strcpy(out->op, nonlin ? "NReLU" : "Neuron");
+    ln->out[j] = out;
+}
+
+static void layer_node_weights_item(void *ctx, int j) {
+    LayerNode *ln = (LayerNode*)ctx;
+    Neuron *neuron = &ln->layer->neurons[j];
+    Value *out = ln->out[j];
+
+    double g = out->grad;
+    if (neuron->config.nonlin == 1) {
+        g *= (out->data > 0 ? 1.0 : 0.01);
+    }
+    ln->grad[j] = g;
+
+    neuron->b->grad += g;
+    for (int k = 0; k < ln->n_x; k++) {
+        int col = ln->idx ? ln->idx[k] : k;
+        neuron->w[col]->grad += ln->node.children[k]->data * g;
+    }
+}
+
+static void layer_node_inputs_item(void *ctx, int k) {
+    LayerNode *ln = (LayerNode*)ctx;
+    int col = ln->idx ? ln->idx[k] : k;
+    double acc = 0.0;
+    for (int j = 0; j < ln->layer->n_neurons; j++) {
+        acc += ln->layer->neurons[j].w[col]->data * ln->grad[j];
+    }
+    ln->x_grad[k] = acc;
+}
+
+static void layer_node_backward(Value *v) {
+    LayerNode *ln = (LayerNode*)v;
+    pool_run(layer_node_weights_item, ln, ln->layer->n_neurons);
+    pool_run(layer_node_inputs_item, ln, ln->n_x);
+    for (int k = 0; k < ln->n_x; k++) {
+        ln->node.children[k]->grad += ln->x_grad[k];
+    }
+}
+
+// Evaluate layer on inputs x (with weight columns idx, or NULL for dense)
+// as one fused node. Everything lives in a single allocation, so freeing
+// the node (e.g. through free_graph) releases it all.
+static Value** layer_call_fused(Layer *layer, Value **x, int *idx, int n_x) {
+    int n = layer->n_neurons;
+    size_t size = sizeof(LayerNode) + (n + n_x) * sizeof(double) + n * sizeof(Value*)
+                  + n_x * sizeof(Value*) + n_x * sizeof(int);
+    LayerNode *ln = (LayerNode*)malloc(size);
+    Value **out = (Value**)malloc(n * sizeof(Value*));
+    if (ln == NULL || out == NULL) {
+        fprintf(stderr, "Failed to allocate layer node\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Value *node = &ln->node;
+    node->data = 0.0;
+    node->grad = 0.0;
+    node->prev[0] = NULL;
+    node->prev[1] = NULL;
+    node->visit = 0;
+    strcpy(node->op, "Layer");
+    node->backward = layer_node_backward;
+
+    ln->layer = layer;
+    ln->n_x = n_x;
+    ln->grad = (double*)(ln + 1);
+    ln->x_grad = ln->grad + n;
+    ln->out = (Value**)(ln->x_grad + n_x);
+    node->children = ln->out + n;
+    node->n_children = n_x;
+    ln->idx = idx ? (int*)(node->children + n_x) : NULL;
+    for (int k = 0; k < n_x; k++) {
+        node->children[k] = x[k];
+        if (idx) ln->idx[k] = idx[k];
+    }
+
+    pool_run(layer_node_forward_item, ln, n);
+    for (int j = 0; j < n; j++) {
+        out[j] = ln->out[j];
+    }
+    return out;
+}
+
 // Layer functions
 void layer_zero_grad(Layer *layer) {
     for (int i = 0; i < layer->n_neurons; i++) {
@@ -111,15 +408,31 @@ void layer_init(Layer *layer, int n_inputs, int n_neurons, NeuronConfig config)
 }
 
 Value** layer_call(Layer *layer, Value **x) {
+    if (layer_is_parallel(layer, layer->neurons[0].n_inputs)) {
+        return layer_call_fused(layer, x, NULL, layer->neurons[0].n_inputs);
+    }
+
     Value **out = (Value**)malloc(layer->n_neurons * sizeof(Value*));
     if (out == NULL) return NULL;
-
     for (int i = 0; i < layer->n_neurons; i++) {
         out[i] = neuron_call(&layer->neurons[i], x);
     }
     return out;
 }
 
+Value** layer_call_sparse(Layer *layer, SparseInput *x) {
+    if (layer_is_parallel(layer, x->nnz) && x->nnz > 0) {
+        return layer_call_fused(layer, x->val, x->idx, x->nnz);
+    }
+
+    Value **out = (Value**)malloc(layer->n_neurons * sizeof(Value*));
+    if (out == NULL) return NULL;
+    for (int i = 0; i < layer->n_neurons; i++) {
+        out[i] = neuron_call_sparse(&layer->neurons[i], x);
+    }
+    return out;
+}
+
 Value** layer_parameters(Layer *layer) {
     int params_per_neuron = layer->neurons[0].n_inputs + 1;
     int n_params = layer->n_neurons * params_per_neuron;
@@ -153,6 +466,23 @@ void mlp_zero_grad(MLP *mlp) {
     }
 }
 
+// Like mlp_zero_grad, but only clears the first-layer weights in cols
+// (the duplicate-free union of the columns touched by the last sparse
+// forward/backward).
+void mlp_zero_grad_sparse(MLP *mlp, int *cols, int n_cols) {
+    Layer *first = &mlp->layers[0];
+    for (int i = 0; i < first->n_neurons; i++) {
+        Neuron *neuron = &first->neurons[i];
+        for (int j = 0; j < n_cols; j++) {
+            neuron->w[cols[j]]->grad = 0;
+        }
+        neuron->b->grad = 0;
+    }
+    for (int i = 1; i < mlp->n_layers; i++) {
+        layer_zero_grad(&mlp->layers[i]);
+    }
+}
+
 void mlp_init(MLP *mlp, int nin, int *nouts, int nouts_len) {
     int *sizes = (int*)malloc((nouts_len + 1) * sizeof(int));
     sizes[0] = nin;
@@ -187,6 +517,19 @@ Value** mlp_call(MLP *mlp, Value **x) {
     return current_x;
 }
 
+// Sparse input feeds the first layer only; deeper layers see dense activations
+Value** mlp_call_sparse(MLP *mlp, SparseInput *x) {
+    Value **current_x = layer_call_sparse(&mlp->layers[0], x);
+
+    for (int i = 1; i < mlp->n_layers; i++) {
+        Value **layer_out = layer_call(&mlp->layers[i], current_x);
+        free(current_x);
+        current_x = layer_out;
+    }
+
+    return current_x;
+}
+
 int mlp_n_params(MLP *mlp) {
     int n_params = 0;
     for (int i = 0; i < mlp->n_layers; i++) {
@@ -197,7 +540,6 @@ int mlp_n_params(MLP *mlp) {
 }
 
 Value** mlp_parameters(MLP *mlp) {
-    int params_per_neuron = mlp->layers[0].neurons[0].n_inputs + 1;
     int n_params = mlp_n_params(mlp);
 
     Value** params = (Value**)malloc(n_params * sizeof(Value*));
@@ -206,6 +548,7 @@ Value** mlp_parameters(MLP *mlp) {
     int pi = 0;
     for (int i = 0; i < mlp->n_layers; i++) {
         Layer *layer = &mlp->layers[i];
+        int params_per_neuron = layer->neurons[0].n_inputs + 1;
         Value** layer_params = layer_parameters(layer);
         for (int j = 0; j < layer->n_neurons * params_per_neuron; j++) {
             params[pi++] = layer_params[j];
@@ -223,3 +566,325 @@ void mlp_free(MLP *mlp) {
     free(mlp->layers);
 }
 
+
+// Plain forward pass on doubles (no graph), used for calibration and timing
+static double neuron_eval(Neuron *neuron, double *x) {
+    double act = neuron->b->data;
+    for (int i = 0; i < neuron->n_inputs; i++) {
+        act += neuron->w[i]->data * x[i];
+    }
+    if (neuron->config.nonlin == 1 && act < 0) {
+        act *= 0.01;  // Same leak as relu() in engine.c
+    }
+    return act;
+}
+
+static void layer_eval(Layer *layer, double *x, double *out) {
+    for (int i = 0; i < layer->n_neurons; i++) {
+        out[i] = neuron_eval(&layer->neurons[i], x);
+    }
+}
+
+static int mlp_max_width(MLP *mlp) {
+    int width = mlp->layers[0].neurons[0].n_inputs;
+    for (int i = 0; i < mlp->n_layers; i++) {
+        if (mlp->layers[i].n_neurons > width) width = mlp->layers[i].n_neurons;
+    }
+    return width;
+}
+
+void mlp_eval(MLP *mlp, double *x, double *out) {
+    int width = mlp_max_width(mlp);
+    double *buf[2] = {malloc(width * sizeof(double)), malloc(width * sizeof(double))};
+
+    double *current_x = x;
+    for (int i = 0; i < mlp->n_layers; i++) {
+        double *layer_out = (i == mlp->n_layers - 1) ? out : buf[i % 2];
+        layer_eval(&mlp->layers[i], current_x, layer_out);
+        current_x = layer_out;
+    }
+
+    free(buf[0]);
+    free(buf[1]);
+}
+
+// Pruning
+static double calib_loss(MLP *mlp, PruneConfig *config) {
+    if (config->calib_y == NULL || config->n_calib == 0) return 0.0;
+
+    int nin = mlp->layers[0].neurons[0].n_inputs;
+    int nout = mlp->layers[mlp->n_layers - 1].n_neurons;
+    double *out = malloc(nout * sizeof(double));
+    double loss = 0.0;
+    for (int s = 0; s < config->n_calib; s++) {
+        mlp_eval(mlp, &config->calib_x[s * nin], out);
+        for (int k = 0; k < nout; k++) {
+            double d = out[k] - config->calib_y[s * nout + k];
+            loss += d * d;
+        }
+    }
+    free(out);
+    return loss / (config->n_calib * nout);
+}
+
+static double calib_seconds(MLP *mlp, PruneConfig *config) {
+    const int reps = 20;
+    if (config->n_calib <= 0) return 0.0;  // Nothing to time
+    int nin = mlp->layers[0].neurons[0].n_inputs;
+    int nout = mlp->layers[mlp->n_layers - 1].n_neurons;
+    double *out = malloc(nout * sizeof(double));
+
+    clock_t start = clock();
+    for (int r = 0; r < reps; r++) {
+        for (int s = 0; s < config->n_calib; s++) {
+            mlp_eval(mlp, &config->calib_x[s * nin], out);
+        }
+    }
+    clock_t end = clock();
+
+    free(out);
+    return (double)(end - start) / CLOCKS_PER_SEC / reps;
+}
+
+// Mean activation (and mean |activation|) of every neuron over the calibration set
+static void calib_activations(MLP *mlp, PruneConfig *config, double **mean, double **mean_abs) {
+    int nin = mlp->layers[0].neurons[0].n_inputs;
+    int width = mlp_max_width(mlp);
+    double *buf[2] = {malloc(width * sizeof(double)), malloc(width * sizeof(double))};
+
+    for (int s = 0; s < config->n_calib; s++) {
+        double *current_x = &config->calib_x[s * nin];
+        for (int l = 0; l < mlp->n_layers; l++) {
+            layer_eval(&mlp->layers[l], current_x, buf[l % 2]);
+            for (int j = 0; j < mlp->layers[l].n_neurons; j++) {
+                mean[l][j] += buf[l % 2][j] / config->n_calib;
+                mean_abs[l][j] += fabs(buf[l % 2][j]) / config->n_calib;
+            }
+            current_x = buf[l % 2];
+        }
+    }
+
+    free(buf[0]);
+    free(buf[1]);
+}
+
+static double neuron_weight_norm(Neuron *neuron) {
+    double norm = 0.0;
+    for (int i = 0; i < neuron->n_inputs; i++) {
+        norm += neuron->w[i]->data * neuron->w[i]->data;
+    }
+    return sqrt(norm);
+}
+
+typedef struct {
+    double score;
+    int index;
+} ScoredNeuron;
+
+static int compare_by_score(const void *a, const void *b) {
+    const ScoredNeuron *na = (const ScoredNeuron*)a;
+    const ScoredNeuron *nb = (const ScoredNeuron*)b;
+    if (na->score != nb->score) return (na->score > nb->score) - (na->score < nb->score);
+    return na->index - nb->index;  // Ties in neuron order, independent of qsort
+}
+
+// Mark the neurons to keep: drop the lowest `ratio` fraction and anything
+// under min_score, but always keep at least the best neuron.
+static int select_neurons(double *score, int n, PruneConfig *config, int *keep) {
+    ScoredNeuron *order = malloc(n * sizeof(ScoredNeuron));
+    for (int j = 0; j < n; j++) {
+        order[j].score = score[j];
+        order[j].index = j;
+    }
+    qsort(order, n, sizeof(ScoredNeuron), compare_by_score);
+
+    int n_remove = (int)(config->ratio * n);
+    int n_kept = 0;
+    for (int r = 0; r < n; r++) {
+        int j = order[r].index;
+        keep[j] = (r >= n_remove && score[j] >= config->min_score) || r == n - 1;
+        n_kept += keep[j];
+    }
+
+    free(order);
+    return n_kept;
+}
+
+// Build a smaller dst from src by removing low-scoring hidden neurons and
+// the matching input weights of the next layer. The output layer is never
+// pruned. With PRUNE_ACTIVATION, the mean output of each removed neuron is
+// folded into the next layer's biases. Returns 0 on success, -1 (leaving
+// dst untouched) if the config is invalid.
+int mlp_prune(MLP *src, MLP *dst, PruneConfig config, PruneReport *report) {
+    if (config.ratio < 0.0 || config.ratio > 1.0) {
+        fprintf(stderr, "Error: prune ratio must be in [0, 1]\n");
+        return -1;
+    }
+    if (config.criterion == PRUNE_ACTIVATION && (config.calib_x == NULL || config.n_calib <= 0)) {
+        fprintf(stderr, "Error: PRUNE_ACTIVATION needs a calibration set\n");
+        return -1;
+    }
+
+    int n_layers = src->n_layers;
+    int **keep = malloc(n_layers * sizeof(int*));
+    int *n_kept = malloc(n_layers * sizeof(int));
+    double **mean = malloc(n_layers * sizeof(double*));
+    double **mean_abs = malloc(n_layers * sizeof(double*));
+    for (int l = 0; l < n_layers; l++) {
+        keep[l] = malloc(src->layers[l].n_neurons * sizeof(int));
+        mean[l] = calloc(src->layers[l].n_neurons, sizeof(double));
+        mean_abs[l] = calloc(src->layers[l].n_neurons, sizeof(double));
+    }
+
+    if (config.criterion == PRUNE_ACTIVATION) {
+        calib_activations(src, &config, mean, mean_abs);
+    }
+
+    // Score and select neurons in every hidden layer
+    for (int l = 0; l < n_layers; l++) {
+        Layer *layer = &src->layers[l];
+        if (l == n_layers - 1) {
+            for (int j = 0; j < layer->n_neurons; j++) keep[l][j] = 1;
+            n_kept[l] = layer->n_neurons;
+            continue;
+        }
+
+        double *score = malloc(layer->n_neurons * sizeof(double));
+        for (int j = 0; j < layer->n_neurons; j++) {
+            if (config.criterion == PRUNE_ACTIVATION) {
+                score[j] = mean_abs[l][j];
+            } else {
+                Layer *next = &src->layers[l + 1];
+                double out_norm = 0.0;
+                for (int k = 0; k < next->n_neurons; k++) {
+                    double w = next->neurons[k].w[j]->data;
+                    out_norm += w * w;
+                }
+                score[j] = neuron_weight_norm(&layer->neurons[j]) * sqrt(out_norm);
+            }
+        }
+        n_kept[l] = select_neurons(score, layer->n_neurons, &config, keep[l]);
+        free(score);
+    }
+
+    // Copy the surviving neurons into dst
+    dst->n_layers = n_layers;
+    dst->layers = (Layer*)malloc(n_layers * sizeof(Layer));
+    for (int l = 0; l < n_layers; l++) {
+        Layer *from = &src->layers[l];
+        Layer *to = &dst->layers[l];
+        int n_inputs = (l == 0) ? from->neurons[0].n_inputs : n_kept[l - 1];
+
+        to->n_neurons = n_kept[l];
+        to->neurons = (Neuron*)malloc(n_kept[l] * sizeof(Neuron));
+
+        int t = 0;
+        for (int j = 0; j < from->n_neurons; j++) {
+            if (!keep[l][j]) continue;
+            Neuron *nf = &from->neurons[j];
+            Neuron *nt = &to->neurons[t++];
+            neuron_alloc(nt, n_inputs, nf->config);
+
+            double bias = nf->b->data;
+            int c = 0;
+            for (int i = 0; i < nf->n_inputs; i++) {
+                if (l == 0 || keep[l - 1][i]) {
+                    nt->w[c++]->data = nf->w[i]->data;
+                } else if (config.criterion == PRUNE_ACTIVATION) {
+                    bias += nf->w[i]->data * mean[l - 1][i];
+                }
+            }
+            nt->b->data = bias;
+        }
+    }
+
+    if (report != NULL) {
+        report->params_before = mlp_n_params(src);
+        report->params_after = mlp_n_params(dst);
+        report->loss_before = calib_loss(src, &config);
+        report->loss_after = calib_loss(dst, &config);
+        report->seconds_before = calib_seconds(src, &config);
+        report->seconds_after = calib_seconds(dst, &config);
+        // Nothing was timed (no calibration set, or below clock resolution)
+        report->speedup = (report->seconds_before > 0 && report->seconds_after > 0)
+                          ? report->seconds_before / report->seconds_after
+                          : 0.0;
+    }
+
+    for (int l = 0; l < n_layers; l++) {
+        free(keep[l]);
+        free(mean[l]);
+        free(mean_abs[l]);
+    }
+    free(keep);
+    free(n_kept);
+    free(mean);
+    free(mean_abs);
+    return 0;
+}
+
+// Adam optimizer
+void adam_init(Adam *opt, MLP *mlp, double lr, double beta1, double beta2, double eps) {
+    opt->params = mlp_parameters(mlp);
+    opt->n_params = mlp_n_params(mlp);
+    opt->m = (double*)calloc(opt->n_params, sizeof(double));
+    opt->v = (double*)calloc(opt->n_params, sizeof(double));
+    if (!opt->params || !opt->m || !opt->v) {
+        fprintf(stderr, "Failed to allocate Adam state\n");
+        exit(EXIT_FAILURE);
+    }
+    opt->t = 0;
+    opt->lr = lr;
+    opt->beta1 = beta1;
+    opt->beta2 = beta2;
+    opt->eps = eps;
+}
+
+static void adam_update(Adam *opt, int i, double bc1, double bc2) {
+    double g = opt->params[i]->grad;
+    opt->m[i] = opt->beta1 * opt->m[i] + (1 - opt->beta1) * g;
+    opt->v[i] = opt->beta2 * opt->v[i] + (1 - opt->beta2) * g * g;
+
+    double m_hat = opt->m[i] / bc1;
+    double v_hat = opt->v[i] / bc2;
+    opt->params[i]->data -= opt->lr * m_hat / (sqrt(v_hat) + opt->eps);
+}
+
+void adam_step(Adam *opt) {
+    opt->t++;
+    double bc1 = 1 - pow(opt->beta1, opt->t);
+    double bc2 = 1 - pow(opt->beta2, opt->t);
+    for (int i = 0; i < opt->n_params; i++) {
+        adam_update(opt, i, bc1, bc2);
+    }
+}
+
+// Lazy Adam: first-layer weights outside cols keep their moments and data
+// untouched, so the step costs O(n_cols) per first-layer neuron instead of
+// O(n_inputs). All other parameters are updated densely. cols must not
+// contain duplicates, or those weights get two Adam updates in one step.
+void adam_step_sparse(Adam *opt, MLP *mlp, int *cols, int n_cols) {
+    opt->t++;
+    double bc1 = 1 - pow(opt->beta1, opt->t);
+    double bc2 = 1 - pow(opt->beta2, opt->t);
+
+    Layer *first = &mlp->layers[0];
+    int params_per_neuron = first->neurons[0].n_inputs + 1;
+    for (int i = 0; i < first->n_neurons; i++) {
+        int base = i * params_per_neuron;
+        for (int j = 0; j < n_cols; j++) {
+            adam_update(opt, base + cols[j], bc1, bc2);
+        }
+        adam_update(opt, base + params_per_neuron - 1, bc1, bc2);  // bias
+    }
+
+    for (int i = first->n_neurons * params_per_neuron; i < opt->n_params; i++) {
+        adam_update(opt, i, bc1, bc2);
+    }
+}
+
+void adam_free(Adam *opt) {
+    free(opt->params);
+    free(opt->m);
+    free(opt->v);
+}
@@ -26,6 +26,46 @@ typedef struct {
     int n_layers;           // Number of layers in the MLP
 } MLP;
 
+typedef struct {
+    int *idx;               // Column indices of the non-zero inputs (distinct)
+    Value **val;            // Input values at those columns
+    int nnz;                // Number of non-zero inputs
+} SparseInput;
+
+typedef struct {
+    Value **params;         // Parameters in mlp_parameters() order
+    double *m;              // 1st moment
+    double *v;              // 2nd moment
+    int n_params;           // Number of parameters
+    int t;                  // Step counter (for bias correction)
+    double lr, beta1, beta2, eps;
+} Adam;
+
+typedef enum {
+    PRUNE_MAGNITUDE,        // |incoming weights| * |outgoing weights|
+    PRUNE_ACTIVATION        // Mean |activation| over the calibration set
+} PruneCriterion;
+
+typedef struct {
+    PruneCriterion criterion;
+    double ratio;           // Fraction of neurons to remove per hidden layer
+    double min_score;       // Neurons scoring below this are removed as well
+    double *calib_x;        // Calibration inputs, n_calib x nin (row-major)
+    double *calib_y;        // Calibration targets, n_calib x nout (may be NULL)
+    int n_calib;            // Number of calibration samples
+} PruneConfig;
+
+typedef struct {
+    int params_before;
+    int params_after;
+    double seconds_before;  // Forward time over the calibration set
+    double seconds_after;
+    double speedup;         // seconds_before / seconds_after; 0 when nothing was
+                            // timed (no calibration set, or below clock resolution)
+    double loss_before;     // Mean squared error on the calibration set
+    double loss_after;
+} PruneReport;
+
 typedef struct {
     Value ***layer_outputs;
     int n_layers;
@@ -34,20 +74,36 @@ typedef struct {
 void neuron_zero_grad(Neuron *neuron);
 void neuron_init(Neuron *neuron, int n_inputs, NeuronConfig config);
 Value* neuron_call(Neuron *neuron, Value **x);
+Value* neuron_call_sparse(Neuron *neuron, SparseInput *x);
 Value** neuron_parameters(Neuron *neuron);
 void neuron_free(Neuron *neuron);
 
+void nn_set_num_threads(int n_threads);
+void nn_set_parallel_threshold(int min_weights);
+
 void layer_zero_grad(Layer *layer);
 void layer_init(Layer *layer, int n_inputs, int n_neurons, NeuronConfig config);
 Value** layer_call(Layer *layer, Value **x);
+Value** layer_call_sparse(Layer *layer, SparseInput *x);
 Value** layer_parameters(Layer *layer);
 void layer_free(Layer *layer);
 
 void mlp_zero_grad(MLP *mlp);
+// cols: duplicate-free union of the input columns active in the step;
+// a repeated column would be cleared/updated twice.
+void mlp_zero_grad_sparse(MLP *mlp, int *cols, int n_cols);
 void mlp_init(MLP *mlp, int nin, int *nouts, int nouts_len);
 Value** mlp_call(MLP *mlp, Value **x);
+Value** mlp_call_sparse(MLP *mlp, SparseInput *x);
 int mlp_n_params(MLP *mlp);
 Value** mlp_parameters(MLP *mlp);
 void mlp_free(MLP *mlp);
+void mlp_eval(MLP *mlp, double *x, double *out);
+int mlp_prune(MLP *src, MLP *dst, PruneConfig config, PruneReport *report);
+
+void adam_init(Adam *opt, MLP *mlp, double lr, double beta1, double beta2, double eps);
+void adam_step(Adam *opt);
+void adam_step_sparse(Adam *opt, MLP *mlp, int *cols, int n_cols);  // cols as for mlp_zero_grad_sparse
+void adam_free(Adam *opt);
 
 #endif
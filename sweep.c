@@ -0,0 +1,379 @@
+// sweep.c
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "sweep.h"
+#include "nn.h"
+#include "engine.h"
+
+// Per-thread deque of configuration ids. The owner pushes and pops at the
+// bottom, idle threads steal from the top.
+typedef struct {
+    pthread_mutex_t lock;
+    int *items;             // Ring buffer, capacity n_configs
+    int capacity;
+    int top;
+    int count;
+} Deque;
+
+typedef struct {
+    MLP mlp;
+    Adam opt;
+} SweepTask;
+
+typedef struct {
+    SweepConfig *configs;
+    int n_configs;
+    SweepData *data;
+    SweepOptions options;
+    SweepResult *results;
+    SweepTask *tasks;
+    Deque *deques;
+    atomic_int n_done;
+
+    // Idle threads sleep until work is queued or the sweep is over
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cv;
+    int n_queued;           // Configurations sitting in any deque
+
+    // Reports at each early-stopping round
+    pthread_mutex_t rounds_lock;
+    double *round_losses;   // n_rounds x n_configs
+    int *round_ids;         // n_rounds x n_configs, who reported each loss
+    int *round_counts;      // n_rounds
+    int *stop_requested;    // Per configuration, guarded by rounds_lock
+} Sweep;
+
+typedef struct {
+    Sweep *sweep;
+    int id;
+} SweepWorker;
+
+static void deque_init(Deque *dq, int capacity) {
+    pthread_mutex_init(&dq->lock, NULL);
+    dq->items = malloc(capacity * sizeof(int));
+    dq->capacity = capacity;
+    dq->top = 0;
+    dq->count = 0;
+}
+
+static void deque_free(Deque *dq) {
+    pthread_mutex_destroy(&dq->lock);
+    free(dq->items);
+}
+
+static void deque_push(Deque *dq, int id) {
+    pthread_mutex_lock(&dq->lock);
+    dq->items[(dq->top + dq->count) % dq->capacity] = id;
+    dq->count++;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+static int deque_pop(Deque *dq) {
+    int id = -1;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count > 0) {
+        dq->count--;
+        id = dq->items[(dq->top + dq->count) % dq->capacity];
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return id;
+}
+
+static int deque_steal(Deque *dq) {
+    int id = -1;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->count > 0) {
+        id = dq->items[dq->top];
+        dq->top = (dq->top + 1) % dq->capacity;
+        dq->count--;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return id;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// One full-batch epoch of mean L2 loss, then one Adam step. Inputs are
+// wrapped in fresh Values so the shared dataset is never written to.
+static double train_epoch(SweepTask *task, SweepData *data) {
+    mlp_zero_grad(&task->mlp);
+
+    Value **x = malloc(data->nin * sizeof(Value*));
+    Value *total_loss = create_value(0.0);
+    for (int s = 0; s < data->n_samples; s++) {
+        for (int i = 0; i < data->nin; i++) {
+            x[i] = create_value(data->x[s * data->nin + i]);
+        }
+        Value **output = mlp_call(&task->mlp, x);
+        for (int k = 0; k < data->nout; k++) {
+            Value *target = create_value(data->y[s * data->nout + k]);
+            total_loss = add(total_loss, power(sub(output[k], target), 2.0));
+        }
+        free(output);
+    }
+    Value *avg_loss = truediv(total_loss, create_value(data->n_samples * data->nout));
+
+    backward(avg_loss);
+    double loss = avg_loss->data;
+    free_graph(avg_loss, task->opt.params, task->opt.n_params);
+    adam_step(&task->opt);
+
+    free(x);
+    return loss;
+}
+
+// Asynchronous successive halving. Every report at a round re-ranks all
+// reports at that round: once min_reports exist, each configuration with
+// too many better peers is flagged to stop. This includes configurations
+// that reported early and have moved on. Returns whether id itself
+// should stop now.
+static int report_round(Sweep *sw, int id, int round, double loss) {
+    pthread_mutex_lock(&sw->rounds_lock);
+    double *losses = &sw->round_losses[round * sw->n_configs];
+    int *ids = &sw->round_ids[round * sw->n_configs];
+    int n = sw->round_counts[round];
+    losses[n] = loss;
+    ids[n] = id;
+    sw->round_counts[round] = ++n;
+
+    if (n >= sw->options.min_reports) {
+        for (int i = 0; i < n; i++) {
+            int better = 0;
+            for (int j = 0; j < n; j++) {
+                if (losses[j] < losses[i]) better++;
+            }
+            if (better >= ceil(sw->options.keep_fraction * n)) {
+                sw->stop_requested[ids[i]] = 1;
+            }
+        }
+    }
+    int stop = sw->stop_requested[id];
+    pthread_mutex_unlock(&sw->rounds_lock);
+    return stop;
+}
+
+static int stop_requested(Sweep *sw, int id) {
+    pthread_mutex_lock(&sw->rounds_lock);
+    int stop = sw->stop_requested[id];
+    pthread_mutex_unlock(&sw->rounds_lock);
+    return stop;
+}
+
+// Train one round of configuration id; returns 1 when it is finished
+static int run_round(Sweep *sw, int id) {
+    SweepResult *result = &sw->results[id];
+    if (stop_requested(sw, id)) {
+        result->stopped = 1;
+        return 1;
+    }
+
+    int epochs = sw->options.epochs_per_round;
+    if (result->epochs + epochs > sw->options.max_epochs) {
+        epochs = sw->options.max_epochs - result->epochs;
+    }
+
+    double start = now_seconds();
+    for (int e = 0; e < epochs; e++) {
+        result->loss = train_epoch(&sw->tasks[id], sw->data);
+    }
+    result->epochs += epochs;
+    result->seconds += now_seconds() - start;
+
+    if (result->epochs >= sw->options.max_epochs) return 1;
+
+    int round = result->epochs / sw->options.epochs_per_round - 1;
+    if (report_round(sw, id, round, result->loss)) {
+        result->stopped = 1;
+        return 1;
+    }
+    return 0;
+}
+
+static void sweep_push(Sweep *sw, int thread, int id) {
+    deque_push(&sw->deques[thread], id);
+    pthread_mutex_lock(&sw->idle_lock);
+    sw->n_queued++;
+    pthread_cond_signal(&sw->idle_cv);
+    pthread_mutex_unlock(&sw->idle_lock);
+}
+
+// Pop from our own deque, else steal; -1 if every deque is empty
+static int sweep_take(Sweep *sw, int thread) {
+    int n_threads = sw->options.n_threads;
+    int id = deque_pop(&sw->deques[thread]);
+    for (int k = 1; id < 0 && k < n_threads; k++) {
+        id = deque_steal(&sw->deques[(thread + k) % n_threads]);
+    }
+    if (id >= 0) {
+        pthread_mutex_lock(&sw->idle_lock);
+        sw->n_queued--;
+        pthread_mutex_unlock(&sw->idle_lock);
+    }
+    return id;
+}
+
+static void sweep_finish(Sweep *sw) {
+    pthread_mutex_lock(&sw->idle_lock);
+    if (atomic_fetch_add(&sw->n_done, 1) + 1 == sw->n_configs) {
+        pthread_cond_broadcast(&sw->idle_cv);
+    }
+    pthread_mutex_unlock(&sw->idle_lock);
+}
+
+static void* sweep_worker(void *arg) {
+    SweepWorker *worker = (SweepWorker*)arg;
+    Sweep *sw = worker->sweep;
+
+    for (;;) {
+        int id = sweep_take(sw, worker->id);
+        if (id < 0) {
+            // Remaining configurations are mid-round elsewhere: sleep until
+            // one is pushed back or the last one finishes
+            pthread_mutex_lock(&sw->idle_lock);
+            while (sw->n_queued == 0 && atomic_load(&sw->n_done) < sw->n_configs) {
+                pthread_cond_wait(&sw->idle_cv, &sw->idle_lock);
+            }
+            int done = atomic_load(&sw->n_done) == sw->n_configs;
+            pthread_mutex_unlock(&sw->idle_lock);
+            if (done) break;
+            continue;
+        }
+
+        if (run_round(sw, id)) {
+            sweep_finish(sw);
+        } else {
+            sweep_push(sw, worker->id, id);
+        }
+    }
+    return NULL;
+}
+
+// Train every configuration on the shared dataset, one per thread at a
+// time. Models are initialized here, on the calling thread, so initial
+// weights only depend on the rand() seed. Early stopping decisions depend
+// on the order in which rounds are reported, so the set of stopped
+// configurations can differ between runs. Returns 0 on success, -1 if the
+// options are invalid.
+int sweep_run(SweepConfig *configs, int n_configs, SweepData *data,
+              SweepOptions options, SweepResult *results) {
+    if (n_configs < 0) {
+        fprintf(stderr, "Error: n_configs must be >= 0\n");
+        return -1;
+    }
+    if (options.max_epochs <= 0) {
+        fprintf(stderr, "Error: max_epochs must be > 0\n");
+        return -1;
+    }
+    if (!(options.keep_fraction > 0.0 && options.keep_fraction <= 1.0)) {
+        fprintf(stderr, "Error: keep_fraction must be in (0, 1]\n");
+        return -1;
+    }
+    if (options.min_reports < 1) {
+        fprintf(stderr, "Error: min_reports must be >= 1\n");
+        return -1;
+    }
+    if (options.n_threads <= 0) {
+        options.n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (options.epochs_per_round <= 0) {
+        options.epochs_per_round = options.max_epochs;
+    }
+
+    Sweep sw;
+    sw.configs = configs;
+    sw.n_configs = n_configs;
+    sw.data = data;
+    sw.options = options;
+    sw.results = results;
+    atomic_init(&sw.n_done, 0);
+    pthread_mutex_init(&sw.idle_lock, NULL);
+    pthread_cond_init(&sw.idle_cv, NULL);
+    sw.n_queued = 0;
+    pthread_mutex_init(&sw.rounds_lock, NULL);
+
+    int n_rounds = options.max_epochs / options.epochs_per_round + 1;
+    sw.round_losses = malloc((size_t)n_rounds * n_configs * sizeof(double));
+    sw.round_ids = malloc((size_t)n_rounds * n_configs * sizeof(int));
+    sw.round_counts = calloc(n_rounds, sizeof(int));
+    sw.stop_requested = calloc(n_configs, sizeof(int));
+
+    sw.tasks = malloc(n_configs * sizeof(SweepTask));
+    for (int i = 0; i < n_configs; i++) {
+        SweepTask *task = &sw.tasks[i];
+        mlp_init(&task->mlp, data->nin, configs[i].nouts, configs[i].nouts_len);
+        adam_init(&task->opt, &task->mlp, configs[i].lr, configs[i].beta1, configs[i].beta2, 1e-8);
+        results[i].loss = 0.0;
+        results[i].epochs = 0;
+        results[i].stopped = 0;
+        results[i].seconds = 0.0;
+    }
+
+    sw.deques = malloc(options.n_threads * sizeof(Deque));
+    for (int t = 0; t < options.n_threads; t++) {
+        deque_init(&sw.deques[t], n_configs);
+    }
+    for (int i = 0; i < n_configs; i++) {
+        sweep_push(&sw, i % options.n_threads, i);
+    }
+
+    pthread_t *threads = malloc(options.n_threads * sizeof(pthread_t));
+    SweepWorker *workers = malloc(options.n_threads * sizeof(SweepWorker));
+    for (int t = 0; t < options.n_threads; t++) {
+        workers[t].sweep = &sw;
+        workers[t].id = t;
+        pthread_create(&threads[t], NULL, sweep_worker, &workers[t]);
+    }
+    for (int t = 0; t < options.n_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    for (int t = 0; t < options.n_threads; t++) {
+        deque_free(&sw.deques[t]);
+    }
+    for (int i = 0; i < n_configs; i++) {
+        adam_free(&sw.tasks[i].opt);
+        mlp_free(&sw.tasks[i].mlp);
+    }
+    free(threads);
+    free(workers);
+    free(sw.deques);
+    free(sw.tasks);
+    free(sw.round_losses);
+    free(sw.round_ids);
+    free(sw.round_counts);
+    free(sw.stop_requested);
+    pthread_mutex_destroy(&sw.rounds_lock);
+    pthread_mutex_destroy(&sw.idle_lock);
+    pthread_cond_destroy(&sw.idle_cv);
+    return 0;
+}
+
+void sweep_print(FILE *f, SweepConfig *configs, int n_configs, SweepResult *results) {
+    int best = -1;
+    for (int i = 0; i < n_configs; i++) {
+        if (!results[i].stopped && (best < 0 || results[i].loss < results[best].loss)) best = i;
+    }
+
+    fprintf(f, "%-4s %-16s %-8s %-6s %-7s %-7s %-12s %-8s %s\n",
+            "id", "layers", "lr", "beta1", "beta2", "epochs", "loss", "seconds", "status");
+    for (int i = 0; i < n_configs; i++) {
+        char layers[64];
+        int len = 0;
+        for (int l = 0; l < configs[i].nouts_len && len < (int)sizeof(layers); l++) {
+            len += snprintf(layers + len, sizeof(layers) - len, l ? "-%d" : "%d", configs[i].nouts[l]);
+        }
+        fprintf(f, "%-4d %-16s %-8g %-6g %-7g %-7d %-12.8f %-8.3f %s\n",
+                i, layers, configs[i].lr, configs[i].beta1, configs[i].beta2,
+                results[i].epochs, results[i].loss, results[i].seconds,
+                results[i].stopped ? "stopped" : (i == best ? "best" : "done"));
+    }
+}
@@ -0,0 +1,41 @@
+// sweep.h
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdio.h>
+#include "nn.h"
+
+typedef struct {
+    int *nouts;             // Layer sizes passed to mlp_init
+    int nouts_len;          // Number of layers
+    double lr, beta1, beta2;
+} SweepConfig;
+
+typedef struct {
+    double *x;              // Inputs, n_samples x nin (row-major, read-only)
+    double *y;              // Targets, n_samples x nout (read-only)
+    int n_samples;
+    int nin;
+    int nout;
+} SweepData;
+
+typedef struct {
+    int n_threads;          // Worker threads (one per core)
+    int max_epochs;         // Full-batch epochs per configuration
+    int epochs_per_round;   // Epochs between early-stopping checks
+    double keep_fraction;   // Fraction of configurations that survive each round
+    int min_reports;        // Reports needed at a round before anyone is stopped
+} SweepOptions;
+
+typedef struct {
+    double loss;            // Loss after the last epoch trained
+    int epochs;             // Epochs actually trained
+    int stopped;            // Early-stopped for falling behind
+    double seconds;         // Wall time spent training this configuration
+} SweepResult;
+
+int sweep_run(SweepConfig *configs, int n_configs, SweepData *data,
+              SweepOptions options, SweepResult *results);
+void sweep_print(FILE *f, SweepConfig *configs, int n_configs, SweepResult *results);
+
+#endif
@@ -0,0 +1,138 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "dist.h"
+#include "nn.h"
+
+static double xs[4][3] = {{2.0, 3.0, -1.0}, {3.0, -1.0, 0.5}, {0.5, 1.0, 1.0}, {1.0, 1.0, -1.0}};
+static double ys[4] = {1.0, -1.0, -1.0, 1.0};
+
+// Mean L2 loss over samples [lo, hi)
+static Value* shard_loss(MLP *mlp, int lo, int hi) {
+    Value* total_loss = create_value(0.0);
+    for (int i = lo; i < hi; i++) {
+        Value* x[3] = {create_value(xs[i][0]), create_value(xs[i][1]), create_value(xs[i][2])};
+        Value** output = mlp_call(mlp, x);
+        total_loss = add(total_loss, power(sub(output[0], create_value(ys[i])), 2.0));
+        free(output);
+    }
+    return truediv(total_loss, create_value(hi - lo));
+}
+
+static double step_fn(MLP *mlp, int rank, int n_workers, int step, void *ctx) {
+    int per_worker = 4 / n_workers;
+    Value* loss = shard_loss(mlp, rank * per_worker, (rank + 1) * per_worker);
+    backward(loss);
+    return loss->data;
+}
+
+// Rank 1 dies in the middle of training
+static double failing_step_fn(MLP *mlp, int rank, int n_workers, int step, void *ctx) {
+    if (rank == 1 && step == 3) _exit(3);
+    return step_fn(mlp, rank, n_workers, step, ctx);
+}
+
+static void get_params(MLP *mlp, double *out) {
+    Value** params = mlp_parameters(mlp);
+    for (int i = 0; i < mlp_n_params(mlp); i++) out[i] = params[i]->data;
+    free(params);
+}
+
+static void set_params(MLP *mlp, double *in) {
+    Value** params = mlp_parameters(mlp);
+    for (int i = 0; i < mlp_n_params(mlp); i++) params[i]->data = in[i];
+    free(params);
+}
+
+static double max_diff(double *a, double *b, int n) {
+    double diff = 0.0;
+    for (int i = 0; i < n; i++) diff = fmax(diff, fabs(a[i] - b[i]));
+    return diff;
+}
+
+// Two workers with half the batch each must match one process on the full batch
+void test_dist_train() {
+    MLP mlp;
+    int nouts[] = {4, 4, 1};
+    mlp_init(&mlp, 3, nouts, 3);
+    int n_params = mlp_n_params(&mlp);
+    const int n_steps = 50;
+
+    double* init = malloc(n_params * sizeof(double));
+    double* ring = malloc(n_params * sizeof(double));
+    double* det = malloc(n_params * sizeof(double));
+    double* det2 = malloc(n_params * sizeof(double));
+    double* serial = malloc(n_params * sizeof(double));
+    double losses[50];
+    get_params(&mlp, init);
+
+    DistConfig config = {.n_workers = 2, .n_steps = n_steps, .deterministic = 0,
+                         .lr = 0.02, .beta1 = 0.9, .beta2 = 0.999, .eps = 1e-8};
+    // An unrelated child of the caller must not be mistaken for a worker
+    fflush(NULL);
+    pid_t other = fork();
+    if (other == 0) _exit(0);
+    int rc = dist_train(&mlp, config, step_fn, NULL, losses);
+    waitpid(other, NULL, 0);
+    get_params(&mlp, ring);
+
+    config.deterministic = 1;
+    set_params(&mlp, init);
+    rc |= dist_train(&mlp, config, step_fn, NULL, NULL);
+    get_params(&mlp, det);
+    set_params(&mlp, init);
+    rc |= dist_train(&mlp, config, step_fn, NULL, NULL);
+    get_params(&mlp, det2);
+
+    // Serial reference on the full batch
+    set_params(&mlp, init);
+    Adam opt;
+    adam_init(&opt, &mlp, 0.02, 0.9, 0.999, 1e-8);
+    for (int step = 0; step < n_steps; step++) {
+        mlp_zero_grad(&mlp);
+        backward(shard_loss(&mlp, 0, 4));
+        adam_step(&opt);
+    }
+    get_params(&mlp, serial);
+
+    // A crashed worker must fail the run and leave the model alone
+    double* before_fail = malloc(n_params * sizeof(double));
+    double* after_fail = malloc(n_params * sizeof(double));
+    get_params(&mlp, before_fail);
+    int rc_fail = dist_train(&mlp, config, failing_step_fn, NULL, NULL);
+    get_params(&mlp, after_fail);
+
+    printf("Distributed Training Test:\n");
+    printf("  Workers exited cleanly:       %s\n", rc == 0 ? "PASS" : "FAIL");
+    printf("  Loss: %.6f -> %.6f (%s)\n", losses[0], losses[n_steps - 1],
+          losses[n_steps - 1] < losses[0] ? "PASS" : "FAIL");
+    printf("  Ring matches serial:          %s\n",
+          max_diff(ring, serial, n_params) < 1e-9 ? "PASS" : "FAIL");
+    printf("  Deterministic matches serial: %s\n",
+          max_diff(det, serial, n_params) < 1e-9 ? "PASS" : "FAIL");
+    printf("  Deterministic is repeatable:  %s\n",
+          max_diff(det, det2, n_params) == 0.0 ? "PASS" : "FAIL");
+    printf("  Crashed worker fails the run: %s\n\n",
+          rc_fail != 0 && max_diff(before_fail, after_fail, n_params) == 0.0 ? "PASS" : "FAIL");
+
+    adam_free(&opt);
+    free(before_fail);
+    free(after_fail);
+    free(init);
+    free(ring);
+    free(det);
+    free(det2);
+    free(serial);
+    mlp_free(&mlp);
+}
+
+int main() {
+    srand(time(NULL));
+
+    test_dist_train();
+
+    return 0;
+}
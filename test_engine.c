@@ -80,6 +80,22 @@ void test_loss() {
     printf("combined: %.2f (expected 6.25)\n", total_loss->data);
 }
 
+void test_backward_many() {
+    // Two losses sharing a (a * b) subgraph, seeded with different weights
+    Value* a = create_value(2.0);
+    Value* b = create_value(3.0);
+    Value* ab = mul(a, b);
+    Value* l1 = add(ab, a);          // l1 = a*b + a
+    Value* l2 = mul(ab, ab);         // l2 = (a*b)^2
+    Value* roots[2] = {l1, l2};
+    double seeds[2] = {1.0, 0.5};
+    backward_many(roots, 2, seeds);
+    // d/da = (b + 1) + 0.5 * 2ab * b = 4 + 18 = 22
+    // d/db = a + 0.5 * 2ab * a = 2 + 12 = 14
+    printf("a.grad: %.1f (expected 22.0)\n", a->grad);
+    printf("b.grad: %.1f (expected 14.0)\n", b->grad);
+}
+
 int main() {
     printf("Testing repr function:\n");
     test_repr();
@@ -102,6 +118,9 @@ int main() {
     printf("\nTesting loss:\n");
     test_loss();
 
+    printf("\nTesting backward_many:\n");
+    test_backward_many();
+
     return 0;
 }
 
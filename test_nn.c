@@ -76,11 +76,9 @@ void test_backward() {
         losses[i] = power(sub(outputs[i][0], targets[i]), 2.0);
     }
     
-    // Backward pass
+    // Backward pass (one shared traversal for all samples)
     mlp_zero_grad(&mlp);
-    for (int i = 0; i < 4; i++) {
-        backward(losses[i]);
-    }
+    backward_many(losses, 4, NULL);
     
     // Check gradients
     Value** params = mlp_parameters(&mlp);
@@ -213,6 +211,234 @@ void test_training() {
     mlp_free(&mlp);
 }
 
+// Sparse input path: must match the dense path and leave inactive columns alone
+void test_sparse() {
+    MLP mlp;
+    int nouts[] = {4, 4, 1};
+    mlp_init(&mlp, 8, nouts, 3);
+
+    // Dense input with two non-zeros at columns 2 and 5
+    Value* dense[8];
+    for (int i = 0; i < 8; i++) dense[i] = create_value(0.0);
+    dense[2]->data = 1.5;
+    dense[5]->data = -0.5;
+
+    int idx[2] = {2, 5};
+    Value* val[2] = {create_value(1.5), create_value(-0.5)};
+    SparseInput sx = {.idx = idx, .val = val, .nnz = 2};
+
+    Value** out_dense = mlp_call(&mlp, dense);
+    Value** out_sparse = mlp_call_sparse(&mlp, &sx);
+    int same_output = fabs(out_dense[0]->data - out_sparse[0]->data) < 1e-12;
+
+    // Dense gradients for the first layer, then sparse ones
+    Neuron *n0 = &mlp.layers[0].neurons[0];
+    mlp_zero_grad(&mlp);
+    backward(out_dense[0]);
+    double dense_grads[8];
+    for (int i = 0; i < 8; i++) dense_grads[i] = n0->w[i]->grad;
+
+    mlp_zero_grad(&mlp);
+    backward(out_sparse[0]);
+    int same_grads = 1;
+    for (int i = 0; i < 8; i++) {
+        if (fabs(n0->w[i]->grad - dense_grads[i]) > 1e-12) same_grads = 0;
+    }
+
+    // Lazy Adam must not move weights of inactive columns
+    double w_before = n0->w[0]->data;
+    double w_active = n0->w[2]->data;
+    Adam opt;
+    adam_init(&opt, &mlp, 0.02, 0.9, 0.999, 1e-8);
+    adam_step_sparse(&opt, &mlp, idx, 2);
+    mlp_zero_grad_sparse(&mlp, idx, 2);
+    int lazy_ok = n0->w[0]->data == w_before && n0->w[2]->data != w_active
+                  && n0->w[2]->grad == 0.0;
+
+    // Dense step: check one parameter against the Adam update by hand
+    int last = opt.n_params - 1;
+    opt.params[last]->grad = 0.5;
+    double m_exp = 0.9 * opt.m[last] + 0.1 * 0.5;
+    double v_exp = 0.999 * opt.v[last] + 0.001 * 0.25;
+    double m_hat = m_exp / (1 - pow(0.9, opt.t + 1));
+    double v_hat = v_exp / (1 - pow(0.999, opt.t + 1));
+    double data_exp = opt.params[last]->data - 0.02 * m_hat / (sqrt(v_hat) + 1e-8);
+    adam_step(&opt);
+    int dense_ok = opt.t == 2 && fabs(opt.params[last]->data - data_exp) < 1e-12;
+
+    printf("Sparse Input Test:\n");
+    printf("  Output matches dense:   %s\n", same_output ? "PASS" : "FAIL");
+    printf("  Grads match dense:      %s\n", same_grads ? "PASS" : "FAIL");
+    printf("  Lazy update skips zero: %s\n", lazy_ok ? "PASS" : "FAIL");
+    printf("  Dense Adam step:        %s\n\n", dense_ok ? "PASS" : "FAIL");
+
+    // Cleanup
+    adam_free(&opt);
+    free(out_dense);
+    free(out_sparse);
+    for (int i = 0; i < 8; i++) free(dense[i]);
+    free(val[0]);
+    free(val[1]);
+    mlp_free(&mlp);
+}
+
+// Pruning dead neurons must shrink the model without changing its outputs
+void test_prune() {
+    MLP mlp;
+    int nouts[] = {8, 8, 1};
+    mlp_init(&mlp, 3, nouts, 3);
+
+    // Kill two neurons of the first hidden layer
+    for (int j = 0; j < 2; j++) {
+        Neuron *dead = &mlp.layers[0].neurons[j];
+        for (int i = 0; i < dead->n_inputs; i++) dead->w[i]->data = 0.0;
+        dead->b->data = 0.0;
+    }
+
+    double calib_x[4 * 3] = {2.0, 3.0, -1.0,  3.0, -1.0, 0.5,  0.5, 1.0, 1.0,  1.0, 1.0, -1.0};
+    double calib_y[4] = {1.0, -1.0, -1.0, 1.0};
+    PruneConfig config = {.criterion = PRUNE_ACTIVATION, .ratio = 0.0, .min_score = 1e-12,
+                          .calib_x = calib_x, .calib_y = calib_y, .n_calib = 4};
+
+    MLP pruned;
+    PruneReport report;
+    // Pruning must not draw from the caller's rand() stream
+    srand(42);
+    int expected_rand = rand();
+    srand(42);
+    int rc = mlp_prune(&mlp, &pruned, config, &report);
+    int rand_untouched = rand() == expected_rand;
+    srand(time(NULL));
+
+    double out_before, out_after;
+    mlp_eval(&mlp, calib_x, &out_before);
+    mlp_eval(&pruned, calib_x, &out_after);
+
+    int expected_params = (3*6 + 6) + (6*8 + 8) + (8*1 + 1);
+    // Activation scoring without a calibration set must be rejected
+    PruneConfig no_calib = config;
+    no_calib.calib_x = NULL;
+    no_calib.n_calib = 0;
+    MLP rejected;
+    int rc_no_calib = mlp_prune(&mlp, &rejected, no_calib, NULL);
+
+    // Magnitude pruning needs no calibration set, but then nothing is timed
+    no_calib.criterion = PRUNE_MAGNITUDE;
+    no_calib.ratio = 0.25;
+    MLP magnitude;
+    PruneReport magnitude_report;
+    int rc_magnitude = mlp_prune(&mlp, &magnitude, no_calib, &magnitude_report);
+
+    printf("Prune Test:\n");
+    printf("  Pruned successfully: %s\n", rc == 0 ? "PASS" : "FAIL");
+    printf("  Missing calibration rejected: %s\n", rc_no_calib != 0 ? "PASS" : "FAIL");
+    printf("  rand() stream untouched: %s\n", rand_untouched ? "PASS" : "FAIL");
+    printf("  Untimed speedup is 0: %s\n",
+          rc_magnitude == 0 && magnitude_report.speedup == 0.0 ? "PASS" : "FAIL");
+    printf("  Params: %d -> %d (%s)\n", report.params_before, report.params_after,
+          report.params_after == expected_params ? "PASS" : "FAIL");
+    printf("  Output unchanged: %s\n", fabs(out_before - out_after) < 1e-12 ? "PASS" : "FAIL");
+    printf("  Loss: %.8f -> %.8f, speedup %.2fx\n\n",
+          report.loss_before, report.loss_after, report.speedup);
+
+    mlp_free(&magnitude);
+    mlp_free(&pruned);
+    mlp_free(&mlp);
+}
+
+// Evaluate 3 samples (dense, plus one sparse) and backward through all of them
+static double run_parallel_case(MLP *mlp, Value* inputs[3][16], SparseInput *sx,
+                                double *param_grads, double *input_grads) {
+    Value** params = mlp_parameters(mlp);
+    int n_params = mlp_n_params(mlp);
+
+    mlp_zero_grad(mlp);
+    for (int s = 0; s < 3; s++) {
+        for (int i = 0; i < 16; i++) inputs[s][i]->grad = 0.0;
+    }
+    Value* roots[4];
+    for (int s = 0; s < 3; s++) {
+        Value** out = mlp_call(mlp, inputs[s]);
+        roots[s] = out[0];
+        free(out);
+    }
+    Value** out_sparse = mlp_call_sparse(mlp, sx);
+    roots[3] = out_sparse[0];
+    free(out_sparse);
+    backward_many(roots, 4, NULL);
+
+    double out_sum = 0.0;
+    for (int r = 0; r < 4; r++) out_sum += roots[r]->data;
+    for (int i = 0; i < n_params; i++) param_grads[i] = params[i]->grad;
+    for (int s = 0; s < 3; s++) {
+        for (int i = 0; i < 16; i++) input_grads[s * 16 + i] = inputs[s][i]->grad;
+    }
+    free(params);
+    return out_sum;
+}
+
+static int close_enough(double *a, double *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (fabs(a[i] - b[i]) > 1e-9 * (1.0 + fabs(a[i]))) return 0;
+    }
+    return 1;
+}
+
+// Fused parallel layers must match the serial graph in outputs, parameter
+// grads and input grads (up to summation order). Sample 2 and the sparse
+// sample reuse one Value at several input positions.
+void test_parallel_layer() {
+    MLP mlp;
+    int nouts[] = {32, 32, 1};
+    mlp_init(&mlp, 16, nouts, 3);
+
+    Value* inputs[3][16];
+    for (int s = 0; s < 3; s++) {
+        for (int i = 0; i < 16; i++) inputs[s][i] = create_value(((double)rand() / RAND_MAX) * 2 - 1);
+    }
+    Value* shared = create_value(0.75);
+    Value* shared_x[16];
+    for (int i = 0; i < 16; i++) {
+        shared_x[i] = inputs[2][i];
+        inputs[2][i] = shared;
+    }
+    int idx[3] = {1, 7, 12};
+    Value* val[3] = {create_value(0.5), create_value(-1.5), NULL};
+    val[2] = val[0];
+    SparseInput sx = {.idx = idx, .val = val, .nnz = 3};
+
+    int n_params = mlp_n_params(&mlp);
+    double* serial_grads = malloc(n_params * sizeof(double));
+    double* parallel_grads = malloc(n_params * sizeof(double));
+    double serial_x[3 * 16], parallel_x[3 * 16];
+
+    double serial_out = run_parallel_case(&mlp, inputs, &sx, serial_grads, serial_x);
+
+    nn_set_num_threads(4);
+    nn_set_parallel_threshold(0);
+    double parallel_out = run_parallel_case(&mlp, inputs, &sx, parallel_grads, parallel_x);
+    nn_set_num_threads(1);
+    nn_set_parallel_threshold(4096);
+
+    printf("Parallel Layer Test:\n");
+    printf("  Output matches serial:      %s\n",
+          fabs(parallel_out - serial_out) < 1e-9 ? "PASS" : "FAIL");
+    printf("  Param grads match serial:   %s\n",
+          close_enough(serial_grads, parallel_grads, n_params) ? "PASS" : "FAIL");
+    printf("  Input grads match serial:   %s\n\n",
+          close_enough(serial_x, parallel_x, 3 * 16) ? "PASS" : "FAIL");
+
+    free(serial_grads);
+    free(parallel_grads);
+    for (int s = 0; s < 3; s++) {
+        for (int i = 0; i < 16; i++) free(s == 2 ? shared_x[i] : inputs[s][i]);
+    }
+    free(shared);
+    free(val[0]);
+    free(val[1]);
+    mlp_free(&mlp);
+}
+
 int main() {
     srand(time(NULL));
     
@@ -220,6 +446,9 @@ int main() {
     test_forward_pass();
     test_backward();
     test_training();
+    test_sparse();
+    test_prune();
+    test_parallel_layer();
     
     return 0;
 }
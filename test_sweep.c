@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sweep.h"
+
+// Six configurations on the 4-sample dataset, run on 3 threads
+void test_sweep() {
+    double x[4 * 3] = {2.0, 3.0, -1.0,  3.0, -1.0, 0.5,  0.5, 1.0, 1.0,  1.0, 1.0, -1.0};
+    double y[4] = {1.0, -1.0, -1.0, 1.0};
+    SweepData data = {.x = x, .y = y, .n_samples = 4, .nin = 3, .nout = 1};
+
+    int small[] = {4, 4, 1};
+    int wide[] = {8, 8, 1};
+    int deep[] = {4, 4, 4, 1};
+    SweepConfig configs[6] = {
+        {small, 3, 0.02, 0.9, 0.999},
+        {small, 3, 0.001, 0.9, 0.999},
+        {wide, 3, 0.02, 0.9, 0.999},
+        {wide, 3, 0.0001, 0.5, 0.9},
+        {deep, 4, 0.02, 0.9, 0.999},
+        {deep, 4, 0.01, 0.8, 0.99},
+    };
+    SweepOptions options = {.n_threads = 3, .max_epochs = 100, .epochs_per_round = 20,
+                            .keep_fraction = 0.5, .min_reports = 2};
+    SweepResult results[6];
+
+    int ok = sweep_run(configs, 6, &data, options, results) == 0;
+    sweep_print(stdout, configs, 6, results);
+
+    // Config 3 (lr = 1e-4) barely moves in 100 epochs and must be cut
+    int slow_stopped = results[3].stopped;
+
+    int all_ran = 1, n_full = 0, n_stopped = 0, stopped_early = 1;
+    for (int i = 0; i < 6; i++) {
+        if (results[i].epochs == 0) all_ran = 0;
+        if (results[i].stopped) {
+            n_stopped++;
+            if (results[i].epochs >= options.max_epochs) stopped_early = 0;
+        } else if (results[i].epochs == options.max_epochs) {
+            n_full++;
+        }
+    }
+    // Options that would divide by zero or stop every configuration
+    SweepOptions no_epochs = options, no_keep = options, no_reports = options;
+    no_epochs.max_epochs = 0;
+    no_keep.keep_fraction = 0.0;
+    no_reports.min_reports = 0;
+    int rejected = sweep_run(configs, 6, &data, no_epochs, results) != 0 &&
+                   sweep_run(configs, 6, &data, no_keep, results) != 0 &&
+                   sweep_run(configs, 6, &data, no_reports, results) != 0;
+
+    printf("\nSweep Test:\n");
+    printf("  Sweep ran:               %s\n", ok ? "PASS" : "FAIL");
+    printf("  Every config trained:    %s\n", all_ran ? "PASS" : "FAIL");
+    printf("  Finished or stopped:     %s\n", n_full + n_stopped == 6 ? "PASS" : "FAIL");
+    printf("  Slow config stopped:     %s\n", slow_stopped ? "PASS" : "FAIL");
+    printf("  Stopped configs (%d) ran short: %s\n", n_stopped, stopped_early ? "PASS" : "FAIL");
+    printf("  Bad options rejected:    %s\n\n", rejected ? "PASS" : "FAIL");
+}
+
+int main() {
+    srand(time(NULL));
+
+    test_sweep();
+
+    return 0;
+}